@@ -0,0 +1,115 @@
+/*
+  This example shows how to use more than one lightning detector on the same
+  site to reject false events. A real lightning strike is picked up by all of
+  the detectors within a few milliseconds of each other, while a local
+  "disturber" (a motor, a light switch...) is usually only picked up by the
+  detector closest to it. Only events that at least two detectors agree on are
+  reported. 
+
+  Two detectors are used here on the same I-squared-C bus, so set the address
+  jumpers on the underside of the second board to 0x02. Each board's "INT" pin
+  is connected to its own interrupt capable pin.
+
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+
+*/
+
+#include <SPI.h>
+#include <Wire.h>
+#include "SparkFun_AS3935.h"
+#include "SparkFun_AS3935_Coincidence.h"
+
+SparkFun_AS3935 lightningOne(0x03);
+SparkFun_AS3935 lightningTwo(0x02);
+
+// Events from the two detectors that are less than 20ms apart are matched,
+// and both of them need to see it. 
+SparkFun_AS3935_Coincidence coincidence(20, 2);
+
+// Interrupt pins for lightning detection 
+const int lightningIntOne = 2; 
+const int lightningIntTwo = 3; 
+
+int8_t sensorOne;
+int8_t sensorTwo;
+
+// Time at which each interrupt pin went HIGH, zero when there is nothing to
+// read. 
+volatile uint32_t eventTimeOne = 0;
+volatile uint32_t eventTimeTwo = 0;
+
+void lightningOneISR()
+{
+  eventTimeOne = millis();
+}
+
+void lightningTwoISR()
+{
+  eventTimeTwo = millis();
+}
+
+void setup()
+{
+  // When lightning is detected the interrupt pin goes HIGH.
+  pinMode(lightningIntOne, INPUT); 
+  pinMode(lightningIntTwo, INPUT); 
+
+  Serial.begin(115200); 
+  Serial.println("AS3935 Franklin Lightning Detector"); 
+
+  Wire.begin(); // Begin Wire before lightning sensor. 
+
+  if( !lightningOne.begin() || !lightningTwo.begin() ) { // Initialize the sensors. 
+    Serial.println ("Lightning Detectors did not start up, freezing!"); 
+    while(1); 
+  }
+  else
+    Serial.println("Schmow-ZoW, Lightning Detectors Ready!");
+
+  sensorOne = coincidence.addSensor(lightningOne);
+  sensorTwo = coincidence.addSensor(lightningTwo);
+
+  attachInterrupt(digitalPinToInterrupt(lightningIntOne), lightningOneISR, RISING);
+  attachInterrupt(digitalPinToInterrupt(lightningIntTwo), lightningTwoISR, RISING);
+}
+
+void loop()
+{
+  uint32_t eventTime;
+
+  noInterrupts();
+  eventTime = eventTimeOne;
+  eventTimeOne = 0;
+  interrupts();
+  if(eventTime)
+    coincidence.readSensor(sensorOne, eventTime);
+
+  noInterrupts();
+  eventTime = eventTimeTwo;
+  eventTimeTwo = 0;
+  interrupts();
+  if(eventTime)
+    coincidence.readSensor(sensorTwo, eventTime);
+
+  // A strike is only passed on once every detector had the chance to report
+  // it, so keep the filter up to date even when nothing new came in. 
+  coincidence.update(millis());
+
+  lightningStrike strike;
+  while(coincidence.read(strike)){
+    Serial.print("Lightning seen by "); 
+    Serial.print(strike.sensorCount); 
+    Serial.println(" detectors!"); 
+    if(strike.distance == DISTANCE_OUT_OF_RANGE){
+      Serial.println("Out of range."); 
+    }
+    else {
+      Serial.print("Approximately: "); 
+      Serial.print(strike.distance); 
+      Serial.println("km away!"); 
+    }
+    Serial.print("Energy: "); 
+    Serial.println(strike.energy); 
+  }
+}
@@ -0,0 +1,61 @@
+/*
+  This example finds the fastest SPI clock that the lightning detector works
+  with on your board and wiring. Clocks close to the 500kHz antenna frequency
+  (and the divided down frequencies the chip can put on the IRQ pin) are
+  skipped, as they cause feedback with the antenna. Each of the other clocks is
+  checked by writing test values to a register and reading them back. 
+
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+*/
+
+#include <SPI.h>
+#include <Wire.h>
+#include "SparkFun_AS3935.h"
+
+// SPI
+SparkFun_AS3935 lightning;
+
+// Chip select pin 
+int spiCS = 10; 
+
+// Clocks to try, in any order. Leave this out of probeBusSpeed() to use the
+// library's default list. 
+uint32_t candidates[] = {2000000, 1000000, 800000, 400000, 200000};
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("AS3935 Franklin Lightning Detector"); 
+
+  SPI.begin(); // For SPI
+  if( !lightning.beginSPI(spiCS) ) { 
+    Serial.println ("Lightning Detector did not start up, freezing!"); 
+    while(1); 
+  }
+  else
+    Serial.println("Schmow-ZoW, Lightning Detector Ready!\n");
+
+  Serial.print("Starting at: "); 
+  Serial.print(lightning.measureBusThroughput()); 
+  Serial.println(" reads per second."); 
+
+  uint32_t readsPerSec; 
+  uint32_t speed = lightning.probeBusSpeed(candidates, sizeof(candidates) / sizeof(candidates[0]), &readsPerSec); 
+
+  if( speed == 0 ) {
+    Serial.println("None of the clocks worked, check your wiring."); 
+  }
+  else {
+    Serial.print("Fastest reliable clock: "); 
+    Serial.print(speed); 
+    Serial.println("Hz"); 
+    Serial.print("Now at: "); 
+    Serial.print(readsPerSec); 
+    Serial.println(" reads per second."); 
+  }
+}
+
+void loop()
+{
+}
@@ -0,0 +1,66 @@
+/*
+  This example records everything the library puts on the bus: every register
+  read, register write and delay, when it happened and which function caused
+  it. This is handy when something odd happens in the field and you need to
+  know exactly what was sent to the lightning detector. 
+
+  Tracing is left out of the library unless it is turned on. Uncomment
+  "#define SFE_AS3935_TRACE" in SparkFun_AS3935_Trace.h, or add
+  -DSFE_AS3935_TRACE to your build flags. Then save what this sketch prints and
+  run it through extras/trace_timeline.py in the library folder to get a
+  timeline. 
+
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+*/
+
+#include <SPI.h>
+#include <Wire.h>
+#include "SparkFun_AS3935.h"
+
+// 0x03 is default, but the address can also be 0x02, 0x01.
+// Adjust the address jumpers on the underside of the product. 
+#define AS3935_ADDR 0x03 
+
+SparkFun_AS3935 lightning(AS3935_ADDR);
+
+#ifdef SFE_AS3935_TRACE
+// Each record is 8 bytes. When the buffer is full the oldest records are
+// overwritten. 
+as3935TraceRecord traceBuffer[64];
+#endif
+
+void setup()
+{
+  Serial.begin(115200); 
+  Serial.println("AS3935 Franklin Lightning Detector"); 
+
+#ifdef SFE_AS3935_TRACE
+  // Give the buffer before begin() so that the start up is recorded as well. 
+  lightning.setTraceBuffer(traceBuffer, sizeof(traceBuffer) / sizeof(traceBuffer[0])); 
+#else
+  Serial.println("Tracing is not turned on, see the top of this sketch."); 
+#endif
+
+  Wire.begin(); // Begin Wire before lightning sensor. 
+
+  if( !lightning.begin() ) { // Initialize the sensor. 
+    Serial.println ("Lightning Detector did not start up, freezing!"); 
+    while(1); 
+  }
+  else
+    Serial.println("Schmow-ZoW, Lightning Detector Ready!");
+
+  // Do a few things worth looking at. 
+  lightning.clearStatistics(true); 
+  lightning.calibrateOsc(); 
+  lightning.lightningEnergy(); 
+
+#ifdef SFE_AS3935_TRACE
+  lightning.dumpTrace(Serial); 
+#endif
+}
+
+void loop()
+{
+}
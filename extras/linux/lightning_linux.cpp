@@ -0,0 +1,72 @@
+/*
+  This program shows how to use the library on a Linux board, talking to the
+  lightning detector through /dev/i2c-N or /dev/spidevB.C. There is no
+  interrupt pin here, so the interrupt register is polled instead.
+
+  Build it from the library folder with:
+
+    g++ -Isrc src/SparkFun_AS3935*.cpp extras/linux/lightning_linux.cpp -o lightning_linux
+
+  Then run one of:
+
+    ./lightning_linux i2c /dev/i2c-1 0x03
+    ./lightning_linux spi /dev/spidev0.0
+
+  A regular file can be given instead of the device, where byte N of the file
+  stands in for register N. This lets you try things out with no hardware:
+
+    truncate -s 64 registers.bin
+    ./lightning_linux i2c registers.bin
+
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SparkFun_AS3935.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 3 || (strcmp(argv[1], "i2c") && strcmp(argv[1], "spi")))
+    {
+        fprintf(stderr, "Usage: %s i2c|spi <device> [i2c address]\n", argv[0]);
+        return 1;
+    }
+
+    bool spi = !strcmp(argv[1], "spi");
+    i2cAddress address = (argc > 3) ? (i2cAddress)strtoul(argv[3], NULL, 0) : defAddr;
+
+    SparkFun_AS3935 lightning(address);
+
+    bool started = spi ? lightning.beginSPI(argv[2]) : lightning.begin(argv[2]);
+    if (!started)
+    {
+        perror("Lightning Detector did not start up");
+        return 1;
+    }
+    printf("Schmow-ZoW, Lightning Detector Ready!\n");
+
+    printf("Noise level: %u\n", lightning.readNoiseLevel());
+    printf("Watchdog threshold: %u\n", lightning.readWatchdogThreshold());
+    printf("Spike rejection: %u\n", lightning.readSpikeRejection());
+
+    while (true)
+    {
+        uint8_t intVal = lightning.readInterruptReg();
+        if (intVal == NOISE_TO_HIGH)
+            printf("Noise.\n");
+        else if (intVal == DISTURBER_DETECT)
+            printf("Disturber.\n");
+        else if (intVal == LIGHTNING)
+        {
+            printf("Lightning Strike Detected!\n");
+            printf("Approximately: %ukm away!\n", lightning.distanceToStorm());
+            printf("Energy: %lu\n", (unsigned long)lightning.lightningEnergy());
+        }
+        usleep(100000);
+    }
+}
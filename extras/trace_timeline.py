@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""
+Turns the output of SparkFun_AS3935::dumpTrace() into a timeline.
+
+The library has to be built with SFE_AS3935_TRACE defined, see
+src/SparkFun_AS3935_Trace.h. Save what the sketch printed to a file and run:
+
+    python3 trace_timeline.py serial_log.txt
+
+Lines that are not part of the dump are skipped, so the whole serial log can be
+given. Register and function names are read from the library headers.
+
+SparkFun Electronics
+License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+"""
+
+import argparse
+import os
+import re
+import sys
+
+SRC_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src")
+
+KINDS = {0: "read", 1: "write", 2: "delay", 3: "addr"}
+
+# Names that do not come out right when turned into camelCase.
+CALLER_NAMES = {"beginSpi": "beginSPI"}
+
+
+def read_enum(path, name):
+    """Returns {value: name} for a C enum, following implicit values."""
+    with open(path) as f:
+        text = f.read()
+    match = re.search(r"enum\s+" + name + r"\s*\{(.*?)\}", text, re.S)
+    if not match:
+        sys.exit("Could not find enum %s in %s" % (name, path))
+
+    body = re.sub(r"//[^\n]*", "", match.group(1))
+    values = {}
+    value = -1
+    for entry in body.split(","):
+        entry = entry.strip()
+        if not entry:
+            continue
+        if "=" in entry:
+            entry, number = [part.strip() for part in entry.split("=")]
+            value = int(number, 0)
+        else:
+            value += 1
+        values.setdefault(value, entry)
+    return values
+
+
+def caller_name(enum_name):
+    """AS3935_TRACE_CLEAR_STATISTICS -> clearStatistics"""
+    words = enum_name.split("_")[2:]
+    name = words[0].lower() + "".join(word.capitalize() for word in words[1:])
+    return CALLER_NAMES.get(name, name)
+
+
+def parse(lines):
+    """Returns the records of the last dump in the log and the number lost."""
+    records = []
+    lost = 0
+    for line in lines:
+        fields = line.split()
+        if fields[:2] == ["#AS3935", "trace"]:
+            records = []
+            lost = int(fields[3]) if len(fields) > 3 else 0
+            continue
+        if len(fields) != 5:
+            continue
+        try:
+            records.append([int(field, 16) for field in fields])
+        except ValueError:
+            continue
+    return records, lost
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("log", nargs="?", help="file holding the dump, stdin if left out")
+    parser.add_argument("--src", default=SRC_DIR, help="library src directory")
+    args = parser.parse_args()
+
+    registers = read_enum(os.path.join(args.src, "SparkFun_AS3935.h"), "SF_AS3935_REGISTER_NAMES")
+    callers = read_enum(os.path.join(args.src, "SparkFun_AS3935_Trace.h"), "SF_AS3935_TRACE_CALLERS")
+
+    if args.log:
+        with open(args.log) as f:
+            records, lost = parse(f)
+    else:
+        records, lost = parse(sys.stdin)
+
+    if not records:
+        sys.exit("No trace records found.")
+    if lost:
+        print("%d older records were overwritten." % lost)
+
+    print("%12s %10s  %-24s %-6s %-22s %s" % ("time(us)", "+us", "function", "op", "register", "value"))
+
+    start = records[0][0]
+    previous = start
+    previous_caller = None
+    for timestamp, kind, reg, value, caller in records:
+        # micros() rolls over every 71 minutes.
+        elapsed = (timestamp - start) & 0xFFFFFFFF
+        delta = (timestamp - previous) & 0xFFFFFFFF
+        previous = timestamp
+
+        name = caller_name(callers[caller]) if caller in callers and caller else "-"
+        if caller != previous_caller:
+            print()
+            previous_caller = caller
+
+        op = KINDS.get(kind, "0x%02X" % kind)
+        if kind == 2:
+            print("%12d %10d  %-24s %-6s %-22s %dms" % (elapsed, delta, name, op, "", value))
+        elif kind == 3:
+            status = "ack" if value == 0 else "no ack (%d)" % value
+            print("%12d %10d  %-24s %-6s %-22s %s" % (elapsed, delta, name, op, "", status))
+        else:
+            register = "0x%02X %s" % (reg, registers.get(reg, ""))
+            print("%12d %10d  %-24s %-6s %-22s 0x%02X" % (elapsed, delta, name, op, register, value))
+
+
+if __name__ == "__main__":
+    main()
@@ -10,39 +10,84 @@
 
 #include "SparkFun_AS3935.h"
 
+#if !defined(ARDUINO)
+#include <time.h>
+
+// Stand-ins for the Arduino functions used in this file. They are kept out of
+// the header so they don't clash with other libraries on Linux boards.
+#define HEX 16
+
+static void delay(unsigned long ms)
+{
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0)
+        ;
+}
+
+static unsigned long micros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+#endif
+
 // Default constructor, to be used with SPI
 SparkFun_AS3935::SparkFun_AS3935()
 {
+#ifdef SFE_AS3935_TRACE
+    _traceBuffer = NULL;
+    _traceSize = 0;
+    _traceCount = 0;
+    _traceIndex = 0;
+    _traceCaller = AS3935_TRACE_NONE;
+#endif
 }
 
 // Another constructor with I2C but receives address from user.
 SparkFun_AS3935::SparkFun_AS3935(i2cAddress address)
 {
     _address = address;
+#ifdef SFE_AS3935_TRACE
+    _traceBuffer = NULL;
+    _traceSize = 0;
+    _traceCount = 0;
+    _traceIndex = 0;
+    _traceCaller = AS3935_TRACE_NONE;
+#endif
 }
 
+#if defined(ARDUINO)
 bool SparkFun_AS3935::begin(TwoWire &wirePort)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_BEGIN);
     // Startup time requires 2ms for the LCO and 2ms more for the RC oscillators
     // which occurs only after the LCO settles. See "Timing" under "Electrical
     // Characteristics" in the datasheet.
     delay(4);
+    AS3935_TRACE_EVENT(AS3935_TRACE_DELAY, 0, 4);
     _i2cPort = &wirePort;
+    _i2cPortSpeed = 0;
     //  _i2cPort->begin(); A call to Wire.begin should occur in sketch
     //  to avoid multiple begins with other sketches.
 
     // A return of 0 indicates success, else an error occurred.
     _i2cPort->beginTransmission(_address);
     uint8_t _ret = _i2cPort->endTransmission();
+    AS3935_TRACE_EVENT(AS3935_TRACE_ADDRESS, 0, _ret);
     return !_ret;
 }
 
 bool SparkFun_AS3935::beginSPI(uint8_t user_CSPin, uint32_t spiPortSpeed, SPIClass &spiPort)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_BEGIN_SPI);
     // Startup time requires 2ms for the LCO and 2ms more for the RC oscillators
     // which occurs only after the LCO settles. See "Timing" under "Electrical
     // Characteristics" in the datasheet.
     delay(4);
+    AS3935_TRACE_EVENT(AS3935_TRACE_DELAY, 0, 4);
     // I'll be using this as my indicator that SPI is to be used and not I2C.
     _i2cPort = NULL;
     _spiPort = &spiPort;
@@ -55,12 +100,49 @@ bool SparkFun_AS3935::beginSPI(uint8_t user_CSPin, uint32_t spiPortSpeed, SPICla
 
     return true;
 }
+#else
+bool SparkFun_AS3935::begin(const char *device)
+{
+    AS3935_TRACE_CALL(AS3935_TRACE_BEGIN);
+    // Startup time requires 2ms for the LCO and 2ms more for the RC oscillators
+    // which occurs only after the LCO settles. See "Timing" under "Electrical
+    // Characteristics" in the datasheet.
+    delay(4);
+    AS3935_TRACE_EVENT(AS3935_TRACE_DELAY, 0, 4);
+
+    if (!_linuxPort.openI2C(device, _address))
+        return false;
+
+    // Reading a register checks that the chip answers at the address. This
+    // can't go through _readRegister() as that doesn't tell if it failed.
+    uint8_t _regVal;
+    if (!_linuxPort.readRegister(AFE_GAIN, _regVal))
+        return false;
+    AS3935_TRACE_EVENT(AS3935_TRACE_READ, AFE_GAIN, _regVal);
+    return true;
+}
+
+bool SparkFun_AS3935::beginSPI(const char *device, uint32_t spiPortSpeed)
+{
+    AS3935_TRACE_CALL(AS3935_TRACE_BEGIN_SPI);
+    // Startup time requires 2ms for the LCO and 2ms more for the RC oscillators
+    // which occurs only after the LCO settles. See "Timing" under "Electrical
+    // Characteristics" in the datasheet.
+    delay(4);
+    AS3935_TRACE_EVENT(AS3935_TRACE_DELAY, 0, 4);
+    _spiPortSpeed = spiPortSpeed; // Make sure it's not 500kHz or it will cause feedback with antenna.
+
+    return _linuxPort.openSPI(device, spiPortSpeed);
+}
+#endif
+
 // REG0x00, bit[0], manufacturer default: 0.
 // The product consumes 1-2uA while powered down. If the board is powered down
 // the the TRCO will need to be recalibrated: REG0x08[5] = 1, wait 2 ms, REG0x08[5] = 0.
 // SPI and I-squared-C remain active when the chip is powered down.
 void SparkFun_AS3935::powerDown()
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_POWER_DOWN);
     _writeRegister(AFE_GAIN, POWER_MASK, 1, 0);
 }
 
@@ -72,7 +154,7 @@ void SparkFun_AS3935::powerDown()
 // calibrated. Note that I-squared-C and SPI are active during power down.
 bool SparkFun_AS3935::wakeUp()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_WAKE_UP);
     _writeRegister(AFE_GAIN, POWER_MASK, 0, 0); // Set the power down bit to zero to wake it up
 
     if (calibrateOsc())
@@ -85,6 +167,7 @@ bool SparkFun_AS3935::wakeUp()
 // This function changes toggles the chip's settings for Indoors and Outdoors.
 void SparkFun_AS3935::setIndoorOutdoor(uint8_t _setting)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_SET_INDOOR_OUTDOOR);
     if (((_setting != INDOOR) && (_setting != OUTDOOR)))
         return;
 
@@ -95,7 +178,7 @@ void SparkFun_AS3935::setIndoorOutdoor(uint8_t _setting)
 // This function returns the indoor/outdoor settting.
 uint8_t SparkFun_AS3935::readIndoorOutdoor()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_INDOOR_OUTDOOR);
     uint8_t regVal = _readRegister(AFE_GAIN);
     return ((regVal &= ~GAIN_MASK) >> 1);
 }
@@ -105,6 +188,7 @@ uint8_t SparkFun_AS3935::readIndoorOutdoor()
 // IRQ Pin.
 void SparkFun_AS3935::watchdogThreshold(uint8_t _sensitivity)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_WATCHDOG_THRESHOLD);
     if (_sensitivity > 10) // 10 is the max sensitivity setting
         return;
 
@@ -116,7 +200,7 @@ void SparkFun_AS3935::watchdogThreshold(uint8_t _sensitivity)
 // IRQ Pin.
 uint8_t SparkFun_AS3935::readWatchdogThreshold()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_WATCHDOG_THRESHOLD);
     uint8_t regVal = _readRegister(THRESHOLD);
     return (regVal &= (~THRESH_MASK));
 }
@@ -128,6 +212,7 @@ uint8_t SparkFun_AS3935::readWatchdogThreshold()
 // Check datasheet for specific noise level tolerances when setting this register.
 void SparkFun_AS3935::setNoiseLevel(uint8_t _floor)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_SET_NOISE_LEVEL);
     if (_floor > 7)
         return;
 
@@ -138,7 +223,7 @@ void SparkFun_AS3935::setNoiseLevel(uint8_t _floor)
 // This function will return the set noise level threshold: default is 2.
 uint8_t SparkFun_AS3935::readNoiseLevel()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_NOISE_LEVEL);
     uint8_t regVal = _readRegister(THRESHOLD);
     return (regVal & ~NOISE_FLOOR_MASK) >> 4;
 }
@@ -150,6 +235,7 @@ uint8_t SparkFun_AS3935::readNoiseLevel()
 // at the cost of sensitivity to distant events.
 void SparkFun_AS3935::spikeRejection(uint8_t _spSensitivity)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_SPIKE_REJECTION);
     if (_spSensitivity > 15)
         return;
 
@@ -163,7 +249,7 @@ void SparkFun_AS3935::spikeRejection(uint8_t _spSensitivity)
 // Increasing this value increases robustness at the cost of sensitivity to distant events.
 uint8_t SparkFun_AS3935::readSpikeRejection()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_SPIKE_REJECTION);
     uint8_t regVal = _readRegister(LIGHTNING_REG);
     return (regVal &= ~SPIKE_MASK);
 }
@@ -173,7 +259,7 @@ uint8_t SparkFun_AS3935::readSpikeRejection()
 // The number of lightning strikes can be set to 1,5,9, or 16.
 void SparkFun_AS3935::lightningThreshold(uint8_t _strikes)
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_LIGHTNING_THRESHOLD);
     uint8_t bits;
 
     if (_strikes == 1)
@@ -195,6 +281,7 @@ void SparkFun_AS3935::lightningThreshold(uint8_t _strikes)
 // a 15 minute window before it triggers an event on the IRQ pin. Default is 1.
 uint8_t SparkFun_AS3935::readLightningThreshold()
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_LIGHTNING_THRESHOLD);
     uint8_t regVal = _readRegister(LIGHTNING_REG);
 
     regVal &= ~LIGHT_MASK;
@@ -217,6 +304,7 @@ uint8_t SparkFun_AS3935::readLightningThreshold()
 // the last 15 minute block.
 void SparkFun_AS3935::clearStatistics(bool _clearStat)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_CLEAR_STATISTICS);
     if (_clearStat != true)
         return;
     // Write high, then low, then high to clear.
@@ -235,10 +323,12 @@ void SparkFun_AS3935::clearStatistics(bool _clearStat)
 // disturber.
 uint8_t SparkFun_AS3935::readInterruptReg()
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_INTERRUPT_REG);
     // A 2ms delay is added to allow for the memory register to be populated
     // after the interrupt pin goes HIGH. See "Interrupt Management" in
     // datasheet.
     delay(2);
+    AS3935_TRACE_EVENT(AS3935_TRACE_DELAY, 0, 2);
 
     uint8_t _interValue;
     _interValue = _readRegister(INT_MASK_ANT);
@@ -251,6 +341,7 @@ uint8_t SparkFun_AS3935::readInterruptReg()
 // This setting will change whether or not disturbers trigger the IRQ Pin.
 void SparkFun_AS3935::maskDisturber(bool _state)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_MASK_DISTURBER);
     _writeRegister(INT_MASK_ANT, DISTURB_MASK, _state, 5);
 }
 
@@ -258,7 +349,7 @@ void SparkFun_AS3935::maskDisturber(bool _state)
 // This setting will return whether or not disturbers trigger the IRQ Pin.
 uint8_t SparkFun_AS3935::readMaskDisturber()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_MASK_DISTURBER);
     uint8_t regVal = _readRegister(INT_MASK_ANT);
     return (regVal &= ~DISTURB_MASK) >> 5;
 }
@@ -269,7 +360,7 @@ uint8_t SparkFun_AS3935::readMaskDisturber()
 // that value for proper signal validation and distance estimation.
 void SparkFun_AS3935::changeDivRatio(uint8_t _divisionRatio)
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_CHANGE_DIV_RATIO);
     uint8_t bits;
 
     if (_divisionRatio == 16)
@@ -294,7 +385,7 @@ void SparkFun_AS3935::changeDivRatio(uint8_t _divisionRatio)
 // the IRQ pin is divided by this number.
 uint8_t SparkFun_AS3935::readDivRatio()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_DIV_RATIO);
     uint8_t regVal = _readRegister(INT_MASK_ANT);
     regVal &= ~DIV_MASK;
     regVal >>= 6; // Front of the line.
@@ -316,7 +407,7 @@ uint8_t SparkFun_AS3935::readDivRatio()
 // distance to a lightning strike.
 uint8_t SparkFun_AS3935::distanceToStorm()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_DISTANCE_TO_STORM);
     uint8_t _dist = _readRegister(DISTANCE);
     _dist &= DISTANCE_MASK;
     return (_dist);
@@ -329,6 +420,7 @@ uint8_t SparkFun_AS3935::distanceToStorm()
 //  _osc 3, bit[7] = LCO - Frequency of the Antenna
 void SparkFun_AS3935::displayOscillator(bool _state, uint8_t _osc)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_DISPLAY_OSCILLATOR);
     if (_osc > 3)
         return;
 
@@ -360,6 +452,7 @@ void SparkFun_AS3935::displayOscillator(bool _state, uint8_t _osc)
 // It's possible to add up to 120pF in steps of 8pF to the antenna.
 void SparkFun_AS3935::tuneCap(uint8_t farad)
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_TUNE_CAP);
     if (farad > 120)
         return;
     else if (farad % 8 != 0)
@@ -376,7 +469,7 @@ void SparkFun_AS3935::tuneCap(uint8_t farad)
 // capacitance.
 uint8_t SparkFun_AS3935::readTuneCap()
 {
-
+    AS3935_TRACE_CALL(AS3935_TRACE_READ_TUNE_CAP);
     uint8_t regVal = _readRegister(FREQ_DISP_IRQ);
     return ((regVal &= ~CAP_MASK) * 8); // Multiplied by 8pF
 }
@@ -389,13 +482,16 @@ uint8_t SparkFun_AS3935::readTuneCap()
 // physical meaning.
 uint32_t SparkFun_AS3935::lightningEnergy()
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_LIGHTNING_ENERGY);
+    uint8_t _energy[3];
+    _readRegisters(ENERGY_LIGHT_LSB, _energy, 3); // Holds LSB, MSB, MMSB
 
-    uint32_t _pureLight = _readRegister(ENERGY_LIGHT_MMSB);
+    uint32_t _pureLight = _energy[2];
     _pureLight &= ENERGY_MASK;
     _pureLight <<= 8;
-    _pureLight |= _readRegister(ENERGY_LIGHT_MSB);
+    _pureLight |= _energy[1];
     _pureLight <<= 8;
-    _pureLight |= _readRegister(ENERGY_LIGHT_LSB);
+    _pureLight |= _energy[0];
     return _pureLight;
 }
 
@@ -407,12 +503,14 @@ uint32_t SparkFun_AS3935::lightningEnergy()
 // Returns true if calibration succedded.
 bool SparkFun_AS3935::calibrateOsc()
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_CALIBRATE_OSC);
     // Send command to calibrate the oscillators
     _writeRegister(CALIB_RCO, WIPE_ALL, DIRECT_COMMAND, 0);
 
     // This procedure is specified in the datasheet
     displayOscillator(true, 2);
     delay(2);
+    AS3935_TRACE_EVENT(AS3935_TRACE_DELAY, 0, 2);
     displayOscillator(false, 2);
 
     // Check they were calibrated successfully.
@@ -431,15 +529,338 @@ bool SparkFun_AS3935::calibrateOsc()
 // This function resets all settings to their default values.
 void SparkFun_AS3935::resetSettings()
 {
+    AS3935_TRACE_CALL(AS3935_TRACE_RESET_SETTINGS);
     _writeRegister(RESET_LIGHT, WIPE_ALL, DIRECT_COMMAND, 0);
 }
 
+// This function changes the clock of the bus the chip was started on. For
+// I-squared-C this changes the clock of the whole bus. Returns false if the
+// clock can't be changed, as for I-squared-C on Linux where the kernel sets it.
+bool SparkFun_AS3935::setBusSpeed(uint32_t speed)
+{
+#if defined(ARDUINO)
+    if (_i2cPort == NULL)
+    {
+        _spiPortSpeed = speed;
+        mySpiSettings = SPISettings(speed, MSBFIRST, SPI_MODE1);
+    }
+    else
+    {
+        _i2cPortSpeed = speed;
+        _i2cPort->setClock(speed);
+    }
+    return true;
+#else
+    if (!_linuxPort.setSpeed(speed))
+        return false;
+
+    _spiPortSpeed = speed;
+    return true;
+#endif
+}
+
+// This function returns the clock given to beginSPI() or setBusSpeed().
+// It returns zero for I-squared-C if the clock was left to the sketch.
+uint32_t SparkFun_AS3935::readBusSpeed()
+{
+#if defined(ARDUINO)
+    if (_i2cPort == NULL)
+        return _spiPortSpeed;
+    else
+        return _i2cPortSpeed;
+#else
+    return _linuxPort.readSpeed();
+#endif
+}
+
+// Settings that only change when they are written, checked by probeBusSpeed()
+// before anything is written at a new clock. Of REG0x03 only the settings are
+// checked, the interrupt bits clear when read, and REG0x04 to REG0x07 are left
+// out as they change with every event. The first PROBE_WRITABLE of them can be
+// written back, the calibration results are only compared.
+static const uint8_t probeRegisters[] = {AFE_GAIN, THRESHOLD, LIGHTNING_REG, INT_MASK_ANT,
+                                         FREQ_DISP_IRQ, CALIB_TRCO, CALIB_SRCO};
+static const uint8_t probeMasks[] = {0xFF, 0xFF, 0xFF, 0xE0, 0xFF, 0xFF, 0xFF};
+#define PROBE_REGISTERS sizeof(probeRegisters)
+#define PROBE_WRITABLE 5
+
+// REG0x01, bits[7:0]
+// This function tries each of the given bus clocks, skipping those close to
+// the antenna frequency. At each clock the settings must first read back as
+// they did at the starting clock, and only then are test patterns written
+// to REG0x01 and read back. Reading REG0x03 clears a pending interrupt. The
+// bus is left at the fastest clock that passed and that clock is returned,
+// or zero if none of them did. If the clock can't be changed, only the
+// current clock is checked and FIXED_BUS_SPEED is returned if it's not
+// known. Settings changed by a failed write are put back from a clock that
+// passed, or the starting clock if it's known. If no list is given a
+// default one for I-squared-C or SPI is used. The measured register reads
+// per second at the chosen clock are always written to transactionsPerSec
+// if it is given.
+uint32_t SparkFun_AS3935::probeBusSpeed(const uint32_t *candidates, uint8_t numCandidates, uint32_t *transactionsPerSec)
+{
+    AS3935_TRACE_CALL(AS3935_TRACE_PROBE_BUS_SPEED);
+    // None of these are near the antenna frequency, see nearAntennaFreq().
+    static const uint32_t spiCandidates[] = {MAX_SPI_SPEED, 1000000, 800000, 400000, 200000};
+    static const uint32_t i2cCandidates[] = {MAX_I2C_SPEED, 300000, 200000};
+
+#if defined(ARDUINO)
+    bool _spi = (_i2cPort == NULL);
+#else
+    bool _spi = _linuxPort.isSPI();
+#endif
+
+    if (candidates == NULL || numCandidates == 0)
+    {
+        if (_spi)
+        {
+            candidates = spiCandidates;
+            numCandidates = sizeof(spiCandidates) / sizeof(spiCandidates[0]);
+        }
+        else
+        {
+            candidates = i2cCandidates;
+            numCandidates = sizeof(i2cCandidates) / sizeof(i2cCandidates[0]);
+        }
+    }
+
+    // Settings are read at the speed the sketch started with, which is known
+    // to work, so the other clocks can be checked against them.
+    uint32_t origSpeed = readBusSpeed();
+    uint8_t settings[PROBE_REGISTERS];
+    for (uint8_t i = 0; i < PROBE_REGISTERS; i++)
+        settings[i] = _readRegister(probeRegisters[i]) & probeMasks[i];
+
+    uint32_t bestSpeed = 0;
+    bool fixedSpeed = false;
+
+    for (uint8_t i = 0; i < numCandidates; i++)
+    {
+        if (candidates[i] <= bestSpeed || nearAntennaFreq(candidates[i]))
+            continue;
+
+        if (!setBusSpeed(candidates[i]))
+        {
+            fixedSpeed = true;
+            break;
+        }
+
+        // Nothing is written at a clock that can't even read correctly, as a
+        // garbled address could change any register.
+        if (!_checkSettings(settings))
+            continue;
+
+        if (_verifyRoundTrip(4))
+        {
+            _restoreSettings(settings);
+            if (_checkSettings(settings))
+            {
+                bestSpeed = candidates[i];
+                continue;
+            }
+        }
+
+        // A write went wrong, so the settings are put back from a clock that
+        // works. Without one the chip is left as it is.
+        uint32_t goodSpeed = bestSpeed ? bestSpeed : origSpeed;
+        if (goodSpeed == 0)
+            break;
+        setBusSpeed(goodSpeed);
+        _restoreSettings(settings);
+    }
+
+    // The clock is set elsewhere, as for I-squared-C on Linux, so only check
+    // the bus at the clock it has, which is the one the settings were read at.
+    if (fixedSpeed)
+    {
+        bool passed = _verifyRoundTrip(4);
+        _restoreSettings(settings);
+        if (passed && _checkSettings(settings))
+            bestSpeed = origSpeed ? origSpeed : FIXED_BUS_SPEED;
+    }
+    else if (bestSpeed != 0)
+        setBusSpeed(bestSpeed);
+    // Nothing passed, go back to where we started. For I-squared-C this was
+    // left to the sketch and so we can't go back.
+    else if (origSpeed != 0)
+        setBusSpeed(origSpeed);
+
+    if (transactionsPerSec != NULL)
+        *transactionsPerSec = measureBusThroughput();
+
+    return bestSpeed;
+}
+
+// This function returns the number of register reads per second at the
+// current bus clock.
+uint32_t SparkFun_AS3935::measureBusThroughput(uint16_t transactions)
+{
+    AS3935_TRACE_CALL(AS3935_TRACE_MEASURE_BUS_THROUGHPUT);
+    if (transactions == 0)
+        return 0;
+
+    uint32_t start = micros();
+    for (uint16_t i = 0; i < transactions; i++)
+        _readRegister(THRESHOLD);
+    uint32_t elapsed = micros() - start;
+
+    if (elapsed == 0)
+        elapsed = 1;
+
+    return (uint32_t)(((uint64_t)transactions * 1000000) / elapsed);
+}
+
+// This function returns true if the given bus clock is close to the
+// antenna frequency or one of its divided frequencies on the IRQ pin.
+bool SparkFun_AS3935::nearAntennaFreq(uint32_t speed)
+{
+    // Divided frequencies on the IRQ pin, the others are harmonics of the
+    // bus clock that land on the antenna frequency.
+    static const uint8_t irqDivisors[] = {16, 32, 64, 128};
+
+    for (uint8_t i = 0; i < ANTENNA_SUBHARMONICS + sizeof(irqDivisors); i++)
+    {
+        uint8_t divisor = (i < ANTENNA_SUBHARMONICS) ? (i + 1) : irqDivisors[i - ANTENNA_SUBHARMONICS];
+        uint32_t freq = ANTENNA_FREQ / divisor;
+        uint32_t guard = (freq * ANTENNA_GUARD_PERCENT) / 100;
+        if (speed >= freq - guard && speed <= freq + guard)
+            return true;
+    }
+    return false;
+}
+
+// REG0x01, bits[7:0]
+// Writes test patterns to the watchdog threshold and noise floor register
+// and checks that they read back correctly. Bit 7 is reserved and left out.
+bool SparkFun_AS3935::_verifyRoundTrip(uint8_t rounds)
+{
+    static const uint8_t patterns[] = {0x55, 0x2A, 0x7F, 0x00};
+
+    for (uint8_t r = 0; r < rounds; r++)
+    {
+        for (uint8_t i = 0; i < sizeof(patterns); i++)
+        {
+            _writeRegister(THRESHOLD, WIPE_ALL, patterns[i], 0);
+            if ((_readRegister(THRESHOLD) & 0x7F) != patterns[i])
+                return false;
+        }
+    }
+    return true;
+}
+
+// Returns true if the registers checked by probeBusSpeed() read back as the
+// given values.
+bool SparkFun_AS3935::_checkSettings(const uint8_t *settings)
+{
+    for (uint8_t i = 0; i < PROBE_REGISTERS; i++)
+    {
+        if ((_readRegister(probeRegisters[i]) & probeMasks[i]) != settings[i])
+            return false;
+    }
+    return true;
+}
+
+// Writes back those of the given values that read differently now. Only
+// registers that differ are written so the trace shows what was changed.
+void SparkFun_AS3935::_restoreSettings(const uint8_t *settings)
+{
+    for (uint8_t i = 0; i < PROBE_WRITABLE; i++)
+    {
+        if ((_readRegister(probeRegisters[i]) & probeMasks[i]) != settings[i])
+            _writeRegister(probeRegisters[i], ~probeMasks[i], settings[i], 0);
+    }
+}
+
+#ifdef SFE_AS3935_TRACE
+// Every register read, register write and delay from here on is written to
+// the given buffer. Once it is full the oldest records are overwritten.
+// Passing NULL stops the recording.
+void SparkFun_AS3935::setTraceBuffer(as3935TraceRecord *buffer, uint16_t size)
+{
+    _traceBuffer = size ? buffer : NULL;
+    _traceSize = size;
+    _traceCount = 0;
+    _traceIndex = 0;
+}
+
+// Returns the number of records written since the buffer was given or
+// cleared. If this is larger than the buffer size the oldest were lost.
+uint32_t SparkFun_AS3935::readTraceCount()
+{
+    return _traceCount;
+}
+
+// Throws away all records.
+void SparkFun_AS3935::clearTrace()
+{
+    _traceCount = 0;
+    _traceIndex = 0;
+}
+
+// Prints the records, oldest first, one per line as hexadecimal:
+// "<timestamp> <kind> <register> <value> <caller>". The first line gives the
+// number of records written and how many of them were lost.
+#if defined(ARDUINO)
+void SparkFun_AS3935::dumpTrace(Print &port)
+#else
+void SparkFun_AS3935::dumpTrace(SparkFun_AS3935_Print &port)
+#endif
+{
+    uint32_t lost = (_traceCount > _traceSize) ? _traceCount - _traceSize : 0;
+
+    port.print("#AS3935 trace ");
+    port.print(_traceCount);
+    port.print(" ");
+    port.println(lost);
+
+    if (_traceBuffer == NULL)
+        return;
+
+    // Once records were lost the oldest one is where the next one goes.
+    uint16_t index = lost ? _traceIndex : 0;
+    for (uint32_t i = lost; i < _traceCount; i++)
+    {
+        as3935TraceRecord &record = _traceBuffer[index];
+        if (++index == _traceSize)
+            index = 0;
+        port.print(record.timestamp, HEX);
+        port.print(" ");
+        port.print(record.kind, HEX);
+        port.print(" ");
+        port.print(record.reg, HEX);
+        port.print(" ");
+        port.print(record.value, HEX);
+        port.print(" ");
+        port.println(record.caller, HEX);
+    }
+}
+
+// Writes one record to the trace buffer. The position wraps with a compare
+// rather than a division, which is slow on 8 bit boards.
+void SparkFun_AS3935::_traceRecord(uint8_t kind, uint8_t reg, uint8_t value)
+{
+    if (_traceBuffer == NULL)
+        return;
+
+    as3935TraceRecord &record = _traceBuffer[_traceIndex];
+    record.timestamp = micros();
+    record.kind = kind;
+    record.reg = reg;
+    record.value = value;
+    record.caller = _traceCaller;
+    _traceCount++;
+    if (++_traceIndex == _traceSize)
+        _traceIndex = 0;
+}
+#endif
+
 // This function handles all I2C write commands. It takes the register to write
 // to, then will mask the part of the register that coincides with the
 // given register, and then write the given bits to the register starting at
 // the given start position.
 void SparkFun_AS3935::_writeRegister(uint8_t _wReg, uint8_t _mask, uint8_t _bits, uint8_t _startPosition)
 {
+#if defined(ARDUINO)
     if (_i2cPort == NULL)
     {
         _spiWrite = _readRegister(_wReg);       // Get the current value of the register
@@ -451,6 +872,7 @@ void SparkFun_AS3935::_writeRegister(uint8_t _wReg, uint8_t _mask, uint8_t _bits
         _spiPort->transfer(_spiWrite); // Write to register
         digitalWrite(_cs, HIGH);       // End communcation
         _spiPort->endTransaction();
+        AS3935_TRACE_EVENT(AS3935_TRACE_WRITE, _wReg, _spiWrite);
     }
     else
     {
@@ -461,13 +883,21 @@ void SparkFun_AS3935::_writeRegister(uint8_t _wReg, uint8_t _mask, uint8_t _bits
         _i2cPort->write(_wReg);                 // at register....
         _i2cPort->write(_i2cWrite);             // Write register...
         _i2cPort->endTransmission();            // End communcation.
+        AS3935_TRACE_EVENT(AS3935_TRACE_WRITE, _wReg, _i2cWrite);
     }
+#else
+    _i2cWrite = _readRegister(_wReg);       // Get the current value of the register
+    _i2cWrite &= _mask;                     // Mask the position we want to write to.
+    _i2cWrite |= (_bits << _startPosition); // Write the given bits to the variable
+    _linuxPort.writeRegister(_wReg, _i2cWrite);
+    AS3935_TRACE_EVENT(AS3935_TRACE_WRITE, _wReg, _i2cWrite);
+#endif
 }
 
 // This function reads the given register.
 uint8_t SparkFun_AS3935::_readRegister(uint8_t _reg)
 {
-
+#if defined(ARDUINO)
     if (_i2cPort == NULL)
     {
         _spiPort->beginTransaction(mySpiSettings);
@@ -480,6 +910,7 @@ uint8_t SparkFun_AS3935::_readRegister(uint8_t _reg)
         digitalWrite(_cs, LOW);
         digitalWrite(_cs, HIGH);
         _spiPort->endTransaction();
+        AS3935_TRACE_EVENT(AS3935_TRACE_READ, _reg & ~SPI_READ_M, _regValue);
         return (_regValue);
     }
     else
@@ -489,6 +920,32 @@ uint8_t SparkFun_AS3935::_readRegister(uint8_t _reg)
         _i2cPort->endTransmission(false);            // 'False' here sends a restart message so that bus is not released
         _i2cPort->requestFrom(_address, (uint8_t)1); // Read the register, only ever once.
         _regValue = _i2cPort->read();
+        AS3935_TRACE_EVENT(AS3935_TRACE_READ, _reg, _regValue);
         return (_regValue);
     }
+#else
+    // A single combined write-then-read, or SPI transfer, on Linux.
+    if (!_linuxPort.readRegister(_reg, _regValue))
+        _regValue = 0;
+    AS3935_TRACE_EVENT(AS3935_TRACE_READ, _reg, _regValue);
+    return (_regValue);
+#endif
+}
+
+// This function reads count registers starting at the given one. On Linux
+// they are all read in a single system call. On Arduino they are read one by
+// one from the highest down, so the energy is read MMSB, MSB, LSB as before.
+void SparkFun_AS3935::_readRegisters(uint8_t _reg, uint8_t *_values, uint8_t _count)
+{
+#if defined(ARDUINO)
+    for (uint8_t i = _count; i > 0; i--)
+        _values[i - 1] = _readRegister(_reg + i - 1);
+#else
+    if (!_linuxPort.readRegisters(_reg, _values, _count))
+        memset(_values, 0, _count);
+#ifdef SFE_AS3935_TRACE
+    for (uint8_t i = 0; i < _count; i++)
+        AS3935_TRACE_EVENT(AS3935_TRACE_READ, _reg + i, _values[i]);
+#endif
+#endif
 }
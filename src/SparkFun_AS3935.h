@@ -1,9 +1,15 @@
 #ifndef _SPARKFUN_AS3935_H_
 #define _SPARKFUN_AS3935_H_
 
+#if defined(ARDUINO)
 #include <Arduino.h>
 #include <SPI.h>
 #include <Wire.h>
+#else
+#include "SparkFun_AS3935_Linux.h"
+#endif
+
+#include "SparkFun_AS3935_Trace.h"
 
 typedef uint8_t i2cAddress;
 
@@ -68,6 +74,24 @@ typedef enum INTERRUPT_STATUS
 #define DIRECT_COMMAND 0x96
 #define UNKNOWN_ERROR 0xFF
 
+// The antenna resonates at 500kHz and the chip can put that frequency divided
+// by 16, 32, 64 or 128 on the IRQ pin. A bus clock at 500kHz divided by a small
+// whole number, such as 250kHz or 100kHz, has a harmonic at 500kHz. Bus clocks
+// within ANTENNA_GUARD_PERCENT of any of these are skipped by probeBusSpeed()
+// as they cause feedback, and are left out of its default lists. Below
+// 500kHz / ANTENNA_SUBHARMONICS the harmonics are too weak to matter.
+#define ANTENNA_FREQ 500000
+#define ANTENNA_GUARD_PERCENT 10
+#define ANTENNA_SUBHARMONICS 10
+
+// Fastest clocks given in the datasheet.
+#define MAX_I2C_SPEED 400000
+#define MAX_SPI_SPEED 2000000
+
+// Returned by probeBusSpeed() when the bus works but its clock is set elsewhere
+// and not known here, as for I-squared-C on Linux.
+#define FIXED_BUS_SPEED 0xFFFFFFFF
+
 class SparkFun_AS3935
 {
   public:
@@ -77,11 +101,19 @@ class SparkFun_AS3935
     // Constructor to be used with I-squared-C.
     SparkFun_AS3935(i2cAddress address);
 
+#if defined(ARDUINO)
     // I-squared-C Begin
     bool begin(TwoWire &wirePort = Wire);
 
     // SPI begin
     bool beginSPI(uint8_t user_CSPin, uint32_t spiPortSpeed = 1000000, SPIClass &spiPort = SPI);
+#else
+    // I-squared-C Begin on Linux, e.g. "/dev/i2c-1".
+    bool begin(const char *device);
+
+    // SPI begin on Linux, e.g. "/dev/spidev0.0".
+    bool beginSPI(const char *device, uint32_t spiPortSpeed = 1000000);
+#endif
 
     // REG0x00, bit[0], manufacturer default: 0.
     // The product consumes 1-2uA while powered down. If the board is powered down
@@ -229,14 +261,72 @@ class SparkFun_AS3935
     // This function resets all settings to their default values.
     void resetSettings();
 
+    // This function changes the clock of the bus the chip was started on. For
+    // I-squared-C this changes the clock of the whole bus. Returns false if the
+    // clock can't be changed, as for I-squared-C on Linux.
+    bool setBusSpeed(uint32_t speed);
+
+    // This function returns the clock given to beginSPI() or setBusSpeed().
+    // It returns zero for I-squared-C if the clock was left to the sketch.
+    uint32_t readBusSpeed();
+
+    // REG0x01, bits[7:0]
+    // This function tries each of the given bus clocks, skipping those close to
+    // the antenna frequency. At each clock the settings must first read back as
+    // they did at the starting clock, and only then are test patterns written
+    // to REG0x01 and read back. Reading REG0x03 clears a pending interrupt. The
+    // bus is left at the fastest clock that passed and that clock is returned,
+    // or zero if none of them did. If the clock can't be changed, only the
+    // current clock is checked and FIXED_BUS_SPEED is returned if it's not
+    // known. Settings changed by a failed write are put back from a clock that
+    // passed, or the starting clock if it's known. If no list is given a
+    // default one for I-squared-C or SPI is used. The measured register reads
+    // per second at the chosen clock are always written to transactionsPerSec
+    // if it is given.
+    uint32_t probeBusSpeed(const uint32_t *candidates = NULL, uint8_t numCandidates = 0,
+                           uint32_t *transactionsPerSec = NULL);
+
+    // This function returns the number of register reads per second at the
+    // current bus clock.
+    uint32_t measureBusThroughput(uint16_t transactions = 100);
+
+    // This function returns true if the given bus clock is close to the
+    // antenna frequency or one of its divided frequencies on the IRQ pin.
+    bool nearAntennaFreq(uint32_t speed);
+
+#ifdef SFE_AS3935_TRACE
+    // Every register read, register write and delay from here on is written to
+    // the given buffer. Once it is full the oldest records are overwritten.
+    // Passing NULL stops the recording.
+    void setTraceBuffer(as3935TraceRecord *buffer, uint16_t size);
+
+    // Returns the number of records written since the buffer was given or
+    // cleared. If this is larger than the buffer size the oldest were lost.
+    uint32_t readTraceCount();
+
+    // Throws away all records.
+    void clearTrace();
+
+    // Prints the records, oldest first, in the format read by
+    // extras/trace_timeline.py.
+#if defined(ARDUINO)
+    void dumpTrace(Print &port);
+#else
+    void dumpTrace(SparkFun_AS3935_Print &port);
+#endif
+#endif
+
   private:
     uint32_t _spiPortSpeed; // Given sport speed.
+    uint32_t _i2cPortSpeed; // Given I-squared-C speed, zero if left to the sketch.
     uint8_t _cs;            // Chip select pin
     uint8_t _regValue;      // Variable for returned register data.
     uint8_t _spiWrite;      // Variable used for SPI write commands.
     uint8_t _i2cWrite;      // Variable used for SPI write commands.
 
+#if defined(ARDUINO)
     SPISettings mySpiSettings;
+#endif
 
     // Address variable.
     i2cAddress _address;
@@ -247,8 +337,35 @@ class SparkFun_AS3935
     void _writeRegister(uint8_t _reg, uint8_t _mask, uint8_t _bits, uint8_t _startPosition);
     // Reads the given register.
     uint8_t _readRegister(uint8_t _reg);
+    // Reads count registers starting at the given one. This is a single bus
+    // transaction where the transport allows it, otherwise the highest
+    // register is read first.
+    void _readRegisters(uint8_t _reg, uint8_t *_values, uint8_t _count);
+    // Writes test patterns to REG0x01 the given number of times and checks
+    // that they read back correctly.
+    bool _verifyRoundTrip(uint8_t rounds);
+    // Returns true if the registers checked by probeBusSpeed() read back as
+    // the given values.
+    bool _checkSettings(const uint8_t *settings);
+    // Writes back those of the given values that read differently now.
+    void _restoreSettings(const uint8_t *settings);
+
+#ifdef SFE_AS3935_TRACE
+    as3935TraceRecord *_traceBuffer; // Given by the sketch.
+    uint16_t _traceSize;
+    uint32_t _traceCount;            // Records written since the last clear.
+    uint16_t _traceIndex;            // Where the next record goes.
+    uint8_t _traceCaller;            // Public function currently running.
+    // Writes one record to the trace buffer.
+    void _traceRecord(uint8_t kind, uint8_t reg, uint8_t value);
+#endif
+#if defined(ARDUINO)
     // I-squared-C and SPI Classes
     TwoWire *_i2cPort;
     SPIClass *_spiPort;
+#else
+    // i2c-dev or spidev device
+    SparkFun_AS3935_LinuxBus _linuxPort;
+#endif
 };
 #endif
@@ -0,0 +1,375 @@
+/*
+  Coincidence filter for several ASM AS3935 Franklin Lightning Detectors on one
+  site. A real strike is seen by most detectors within a few milliseconds while
+  a local disturber is usually only seen by the one closest to it, so only
+  events that more than one detector agrees on are reported as lightning.
+
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+
+  Feel like supporting our work? Buy a board from SparkFun!
+*/
+
+#include "SparkFun_AS3935_Coincidence.h"
+
+SparkFun_AS3935_Coincidence::SparkFun_AS3935_Coincidence(uint32_t windowMs, uint8_t minSensors)
+{
+    _numSensors = 0;
+    _window = windowMs;
+    _minSensors = minSensors ? minSensors : 1;
+    clear();
+}
+
+// Attaches an already started detector to the filter. Returns the index used
+// to refer to this sensor, or -1 if AS3935_MAX_SENSORS has been reached.
+int8_t SparkFun_AS3935_Coincidence::addSensor(SparkFun_AS3935 &sensor)
+{
+    if (_numSensors >= AS3935_MAX_SENSORS)
+        return -1;
+
+    _sensors[_numSensors] = &sensor;
+    return _numSensors++;
+}
+
+// Sets the time in milliseconds in which events from different sensors are
+// matched together.
+void SparkFun_AS3935_Coincidence::setCoincidenceWindow(uint32_t windowMs)
+{
+    _window = windowMs;
+}
+
+uint32_t SparkFun_AS3935_Coincidence::readCoincidenceWindow()
+{
+    return _window;
+}
+
+// Sets how many distinct sensors must see an event before it is reported
+// as lightning. Values of zero are ignored.
+void SparkFun_AS3935_Coincidence::setMinSensors(uint8_t minSensors)
+{
+    if (minSensors == 0)
+        return;
+
+    _minSensors = minSensors;
+}
+
+uint8_t SparkFun_AS3935_Coincidence::readMinSensors()
+{
+    return _minSensors;
+}
+
+// Call this after the IRQ pin of the given sensor went HIGH, with the time
+// that it happened. Noise and disturber interrupts are read to clear them but
+// are otherwise ignored.
+bool SparkFun_AS3935_Coincidence::readSensor(uint8_t sensorIndex, uint32_t timestamp)
+{
+    if (sensorIndex >= _numSensors)
+        return false;
+
+    SparkFun_AS3935 *sensor = _sensors[sensorIndex];
+    if (sensor->readInterruptReg() != LIGHTNING)
+        return false;
+
+    uint8_t distance = sensor->distanceToStorm();
+    uint32_t energy = sensor->lightningEnergy();
+    return addEvent(sensorIndex, timestamp, energy, distance);
+}
+
+// Adds an event to the time ordered buffer and matches it against the events
+// of the other sensors. The buffer has a fixed size, so the work done here is
+// bounded by AS3935_EVENT_BUFFER_SIZE and not by the number of sensors.
+// Strikes are held until their window has closed, so that every sensor that
+// saw them counts towards the energy and distance.
+bool SparkFun_AS3935_Coincidence::addEvent(uint8_t sensorIndex, uint32_t timestamp, uint32_t energy, uint8_t distance)
+{
+    if (sensorIndex >= AS3935_MAX_SENSORS)
+        return false;
+
+    if (_eventCount == 0 || (int32_t)(timestamp - _newest) > 0)
+        _newest = timestamp;
+
+    lightningEvent event;
+    event.timestamp = timestamp;
+    event.energy = energy;
+    event.distance = distance;
+    event.sensor = sensorIndex;
+    event.strikeStart = 0;
+    event.strikeMask = 0;
+
+    // Late events are still matched against what is left in the buffer before
+    // old events are dropped.
+    _matchEvent(_insertEvent(event));
+    bool found = update(_newest);
+    _expireEvents();
+    return found;
+}
+
+// Strikes are only passed on once their window has closed. Call this with the
+// current millis() when no new events come in, so the last strike is not held
+// back until the next one. Returns true if a strike was passed on.
+bool SparkFun_AS3935_Coincidence::update(uint32_t now)
+{
+    bool found = false;
+
+    uint8_t i = 0;
+    while (i < _pendingCount)
+    {
+        if ((uint32_t)(now - _pendingStart[i]) > _window)
+        {
+            _releaseStrike(i);
+            found = true;
+        }
+        else
+            i++;
+    }
+
+    return found;
+}
+
+// Returns the number of corroborated strikes waiting to be read.
+uint8_t SparkFun_AS3935_Coincidence::available()
+{
+    return _strikeCount;
+}
+
+// Copies out the oldest corroborated strike. Returns false if there is none.
+bool SparkFun_AS3935_Coincidence::read(lightningStrike &strike)
+{
+    if (_strikeCount == 0)
+        return false;
+
+    strike = _strikes[_strikeHead];
+    _strikeHead = (_strikeHead + 1) % AS3935_STRIKE_BUFFER_SIZE;
+    _strikeCount--;
+    return true;
+}
+
+// Drops all buffered events and strikes.
+void SparkFun_AS3935_Coincidence::clear()
+{
+    _eventHead = 0;
+    _eventCount = 0;
+    _newest = 0;
+    _strikeHead = 0;
+    _strikeCount = 0;
+    _pendingCount = 0;
+}
+
+// Returns the ring buffer index of the n-th oldest event.
+uint8_t SparkFun_AS3935_Coincidence::_eventAt(uint8_t n)
+{
+    return (_eventHead + n) % AS3935_EVENT_BUFFER_SIZE;
+}
+
+// Puts the event at the end of the buffer and moves it back until the buffer is
+// in time order again. Events nearly always arrive in order, so this rarely
+// moves more than one or two places. If the buffer is full the oldest event is
+// dropped.
+uint8_t SparkFun_AS3935_Coincidence::_insertEvent(const lightningEvent &event)
+{
+    if (_eventCount == AS3935_EVENT_BUFFER_SIZE)
+    {
+        _eventHead = _eventAt(1);
+        _eventCount--;
+    }
+
+    uint8_t n = _eventCount++;
+    _events[_eventAt(n)] = event;
+
+    while (n > 0)
+    {
+        lightningEvent &prev = _events[_eventAt(n - 1)];
+        lightningEvent &cur = _events[_eventAt(n)];
+        if ((int32_t)(cur.timestamp - prev.timestamp) >= 0)
+            break;
+
+        lightningEvent swap = prev;
+        prev = cur;
+        cur = swap;
+        n--;
+    }
+
+    return n;
+}
+
+// A group only holds events within one window of its earliest event, so a new
+// event is matched against events up to one window before it. Events may
+// also arrive up to one window late, so only events more than two windows
+// older than the newest one can not be matched by anything that comes later.
+void SparkFun_AS3935_Coincidence::_expireEvents()
+{
+    while (_eventCount > 0 && (uint32_t)(_newest - _events[_eventHead].timestamp) > 2 * _window)
+    {
+        _eventHead = _eventAt(1);
+        _eventCount--;
+    }
+}
+
+// Looks at the events around the n-th event. As the buffer is in time order
+// only its neighbours are checked.
+//
+// If a strike was already found that this sensor was not part of, and the
+// event lies within the window of the strike's first event, it joins that
+// strike so a sensor that reports late does not cause a second one.
+// Otherwise each unclaimed event up to one window before it, oldest first, is
+// tried as the start of a group holding the unclaimed events within the
+// window after it. The first group that enough distinct sensors saw becomes a
+// strike. Starting from the oldest event keeps the groups the same no
+// matter in which order the sensors report, as long as none of them is more
+// than a window late.
+void SparkFun_AS3935_Coincidence::_matchEvent(uint8_t n)
+{
+    lightningEvent &event = _events[_eventAt(n)];
+    uint32_t sensorBit = (1UL << event.sensor);
+
+    uint8_t first = n;
+    while (first > 0 && _inWindow(_events[_eventAt(first - 1)].timestamp, event.timestamp))
+        first--;
+
+    uint8_t last = n;
+    while (last + 1 < _eventCount && _inWindow(event.timestamp, _events[_eventAt(last + 1)].timestamp))
+        last++;
+
+    for (uint8_t i = first; i <= last; i++)
+    {
+        lightningEvent &other = _events[_eventAt(i)];
+        if (!other.strikeMask || (other.strikeMask & sensorBit) || !_inWindow(other.strikeStart, event.timestamp))
+            continue;
+
+        // Part of a strike that has already been found. Its events are
+        // updated so that this sensor can not join it a second time.
+        uint32_t strikeStart = other.strikeStart;
+        uint32_t strikeMask = other.strikeMask;
+        for (uint8_t j = 0; j < _pendingCount; j++)
+        {
+            if (_pendingStart[j] == strikeStart && _pendingMask[j] == strikeMask)
+                _pendingMask[j] |= sensorBit;
+        }
+        for (uint8_t j = first; j <= last; j++)
+        {
+            lightningEvent &member = _events[_eventAt(j)];
+            if (member.strikeMask == strikeMask && member.strikeStart == strikeStart)
+                member.strikeMask |= sensorBit;
+        }
+        event.strikeStart = strikeStart;
+        event.strikeMask = strikeMask | sensorBit;
+        return;
+    }
+
+    for (uint8_t start = first; start <= n; start++)
+    {
+        uint32_t startTime = _events[_eventAt(start)].timestamp;
+        if (_events[_eventAt(start)].strikeMask)
+            continue;
+
+        uint32_t mask = 0;
+        uint8_t count = 0;
+        uint8_t end = start;
+
+        for (uint8_t i = start; i < _eventCount; i++)
+        {
+            lightningEvent &member = _events[_eventAt(i)];
+            if (!_inWindow(startTime, member.timestamp))
+                break;
+
+            end = i;
+            if (!member.strikeMask && !(mask & (1UL << member.sensor)))
+            {
+                mask |= (1UL << member.sensor);
+                count++;
+            }
+        }
+
+        if (count >= _minSensors)
+        {
+            _claimStrike(start, end, mask);
+            return;
+        }
+    }
+}
+
+// Claims the unclaimed events from the start-th to the end-th event as one
+// strike, which is held until its window has closed.
+void SparkFun_AS3935_Coincidence::_claimStrike(uint8_t start, uint8_t end, uint32_t mask)
+{
+    uint32_t strikeStart = _events[_eventAt(start)].timestamp;
+
+    for (uint8_t i = start; i <= end; i++)
+    {
+        lightningEvent &event = _events[_eventAt(i)];
+        if (event.strikeMask)
+            continue;
+
+        event.strikeStart = strikeStart;
+        event.strikeMask = mask;
+    }
+
+    // If too many strikes are waiting the oldest one is passed on early.
+    if (_pendingCount == AS3935_STRIKE_BUFFER_SIZE)
+        _releaseStrike(0);
+
+    _pendingStart[_pendingCount] = strikeStart;
+    _pendingMask[_pendingCount] = mask;
+    _pendingCount++;
+}
+
+// Passes on the i-th waiting strike, made of every buffered event that was
+// claimed for it. Only the first event of each sensor counts towards the
+// energy and distance.
+void SparkFun_AS3935_Coincidence::_releaseStrike(uint8_t i)
+{
+    lightningStrike strike;
+    strike.timestamp = _pendingStart[i];
+    strike.sensorMask = _pendingMask[i];
+    strike.sensorCount = 0;
+
+    uint32_t used = 0;
+    uint32_t energy = 0;
+    uint16_t distance = 0;
+    uint8_t inRange = 0;
+
+    for (uint8_t n = 0; n < _eventCount; n++)
+    {
+        lightningEvent &event = _events[_eventAt(n)];
+        if (event.strikeStart != strike.timestamp || event.strikeMask != strike.sensorMask)
+            continue;
+
+        if (used & (1UL << event.sensor))
+            continue;
+        used |= (1UL << event.sensor);
+        strike.sensorCount++;
+
+        energy += event.energy;
+        if (event.distance != DISTANCE_OUT_OF_RANGE)
+        {
+            distance += event.distance;
+            inRange++;
+        }
+    }
+
+    strike.energy = strike.sensorCount ? (energy / strike.sensorCount) : 0;
+    strike.distance = inRange ? (distance / inRange) : DISTANCE_OUT_OF_RANGE;
+
+    _pendingCount--;
+    for (uint8_t j = i; j < _pendingCount; j++)
+    {
+        _pendingStart[j] = _pendingStart[j + 1];
+        _pendingMask[j] = _pendingMask[j + 1];
+    }
+
+    // If the sketch is not reading strikes out the oldest one is dropped.
+    if (_strikeCount == AS3935_STRIKE_BUFFER_SIZE)
+    {
+        _strikeHead = (_strikeHead + 1) % AS3935_STRIKE_BUFFER_SIZE;
+        _strikeCount--;
+    }
+    _strikes[(_strikeHead + _strikeCount) % AS3935_STRIKE_BUFFER_SIZE] = strike;
+    _strikeCount++;
+}
+
+// Returns true if the two timestamps lie within the coincidence window. The
+// subtraction keeps this correct when millis() rolls over.
+bool SparkFun_AS3935_Coincidence::_inWindow(uint32_t first, uint32_t second)
+{
+    return (uint32_t)(second - first) <= _window;
+}
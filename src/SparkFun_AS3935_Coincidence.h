@@ -0,0 +1,148 @@
+#ifndef _SPARKFUN_AS3935_COINCIDENCE_H_
+#define _SPARKFUN_AS3935_COINCIDENCE_H_
+
+#include "SparkFun_AS3935.h"
+
+// Number of detectors that can be attached to one filter. Each sensor takes one
+// bit of a 32 bit mask so this can not go beyond 32.
+#ifndef AS3935_MAX_SENSORS
+#define AS3935_MAX_SENSORS 8
+#endif
+
+#if AS3935_MAX_SENSORS > 32
+#error "AS3935_MAX_SENSORS can not be more than 32"
+#endif
+
+// Number of events held in the time ordered buffer. This bounds the work done
+// for every new event no matter how many sensors are attached.
+#ifndef AS3935_EVENT_BUFFER_SIZE
+#define AS3935_EVENT_BUFFER_SIZE 16
+#endif
+
+#if AS3935_EVENT_BUFFER_SIZE > 255 || AS3935_EVENT_BUFFER_SIZE == 0
+#error "AS3935_EVENT_BUFFER_SIZE must be between 1 and 255"
+#endif
+
+// A strike seen by every sensor must fit in the buffer at once.
+#if AS3935_EVENT_BUFFER_SIZE < AS3935_MAX_SENSORS
+#error "AS3935_EVENT_BUFFER_SIZE can not be less than AS3935_MAX_SENSORS"
+#endif
+
+// Number of corroborated strikes that can wait to be read, and that can wait
+// for their window to close.
+#ifndef AS3935_STRIKE_BUFFER_SIZE
+#define AS3935_STRIKE_BUFFER_SIZE 4
+#endif
+
+// Default window, in milliseconds, in which events from different sensors are
+// considered to belong to the same strike.
+#define DEFAULT_COINCIDENCE_WINDOW 20
+
+// The distance register reads 0x3F when the storm is out of range.
+#define DISTANCE_OUT_OF_RANGE 0x3F
+
+// A single lightning event as reported by one sensor.
+typedef struct
+{
+    uint32_t timestamp;   // millis() at the time the IRQ pin went HIGH.
+    uint32_t energy;      // Value of lightningEnergy().
+    uint8_t distance;     // Value of distanceToStorm().
+    uint8_t sensor;       // Index returned by addSensor().
+    uint32_t strikeStart; // Timestamp of the strike this is part of.
+    uint32_t strikeMask;  // Sensors of that strike, zero if not part of one.
+} lightningEvent;
+
+// A strike that was seen by at least the minimum number of sensors.
+typedef struct
+{
+    uint32_t timestamp;  // Timestamp of the earliest matching event.
+    uint32_t energy;     // Average energy of every sensor in sensorMask.
+    uint8_t distance;    // Average distance of the sensors in sensorMask that
+                         // were in range, or DISTANCE_OUT_OF_RANGE if none were.
+    uint8_t sensorCount; // Number of sensors in sensorMask.
+    uint32_t sensorMask; // Bit n is set if sensor n saw the strike within the
+                         // window of its earliest event.
+} lightningStrike;
+
+class SparkFun_AS3935_Coincidence
+{
+  public:
+    SparkFun_AS3935_Coincidence(uint32_t windowMs = DEFAULT_COINCIDENCE_WINDOW, uint8_t minSensors = 2);
+
+    // Attaches an already started detector to the filter. Returns the index used
+    // to refer to this sensor, or -1 if AS3935_MAX_SENSORS has been reached.
+    int8_t addSensor(SparkFun_AS3935 &sensor);
+
+    // Sets the time in milliseconds in which events from different sensors are
+    // matched together.
+    void setCoincidenceWindow(uint32_t windowMs);
+    uint32_t readCoincidenceWindow();
+
+    // Sets how many distinct sensors must see an event before it is reported
+    // as lightning. Values of zero are ignored.
+    void setMinSensors(uint8_t minSensors);
+    uint8_t readMinSensors();
+
+    // Call this after the IRQ pin of the given sensor went HIGH, with the time
+    // that it happened. The interrupt register is read and lightning events are
+    // passed on to addEvent(). Returns true if a corroborated strike is now
+    // available.
+    bool readSensor(uint8_t sensorIndex, uint32_t timestamp);
+
+    // Adds an event that was read by the sketch. Returns true if a corroborated
+    // strike is now available.
+    bool addEvent(uint8_t sensorIndex, uint32_t timestamp, uint32_t energy, uint8_t distance);
+
+    // Strikes are only made available once their window has closed, so that
+    // sensors that report a little later are included. Call this with the
+    // current millis() when no new events come in. Returns true if a
+    // corroborated strike is now available.
+    bool update(uint32_t now);
+
+    // Returns the number of corroborated strikes waiting to be read.
+    uint8_t available();
+
+    // Copies out the oldest corroborated strike. Returns false if there is none.
+    bool read(lightningStrike &strike);
+
+    // Drops all buffered events and strikes.
+    void clear();
+
+  private:
+    SparkFun_AS3935 *_sensors[AS3935_MAX_SENSORS];
+    uint8_t _numSensors;
+    uint32_t _window;
+    uint8_t _minSensors;
+
+    // Events are kept in a ring buffer sorted by timestamp, oldest at _eventHead.
+    lightningEvent _events[AS3935_EVENT_BUFFER_SIZE];
+    uint8_t _eventHead;
+    uint8_t _eventCount;
+    uint32_t _newest; // Newest timestamp seen so far.
+
+    lightningStrike _strikes[AS3935_STRIKE_BUFFER_SIZE];
+    uint8_t _strikeHead;
+    uint8_t _strikeCount;
+
+    // Strikes waiting for their window to close, oldest first.
+    uint32_t _pendingStart[AS3935_STRIKE_BUFFER_SIZE];
+    uint32_t _pendingMask[AS3935_STRIKE_BUFFER_SIZE];
+    uint8_t _pendingCount;
+
+    // Returns the ring buffer index of the n-th oldest event.
+    uint8_t _eventAt(uint8_t n);
+    // Puts the event into the buffer in time order and returns its position.
+    uint8_t _insertEvent(const lightningEvent &event);
+    // Drops events that are too old to match anything that comes later.
+    void _expireEvents();
+    // Looks for other sensors that saw the n-th event and holds a strike if
+    // enough of them did.
+    void _matchEvent(uint8_t n);
+    // Holds a strike made of the unclaimed events from start to end.
+    void _claimStrike(uint8_t start, uint8_t end, uint32_t mask);
+    // Makes the i-th held strike available to read().
+    void _releaseStrike(uint8_t i);
+    // Returns true if the two timestamps lie within the coincidence window.
+    bool _inWindow(uint32_t first, uint32_t second);
+};
+#endif
@@ -0,0 +1,299 @@
+/*
+  Linux transport for the ASM AS3935 Franklin Lightning Detector. Talks to the
+  chip from userspace through the i2c-dev and spidev drivers.
+
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer if you use this and we meet someday (Beerware license).
+
+  Feel like supporting our work? Buy a board from SparkFun!
+*/
+
+#include "SparkFun_AS3935_Linux.h"
+
+#if !defined(ARDUINO) && defined(__linux__)
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <linux/spi/spidev.h>
+
+// A register read takes two I2C messages or two SPI transfers, and the kernel
+// takes at most 42 I2C messages in one call.
+#define MAX_BURST (I2C_RDWR_IOCTL_MAX_MSGS / 2)
+
+// SPI read command bit, see SF_AS3935_REGSTER_MASKS.
+#define LINUX_SPI_READ 0x40
+
+SparkFun_AS3935_LinuxBus::SparkFun_AS3935_LinuxBus()
+{
+    _fd = -1;
+    _mode = BUS_CLOSED;
+    _spi = false;
+    _address = 0;
+    _speed = 0;
+}
+
+SparkFun_AS3935_LinuxBus::~SparkFun_AS3935_LinuxBus()
+{
+    close();
+}
+
+// Opens an I-squared-C bus at the given address. Checks once what the adapter
+// can do so that every read after this is a single system call.
+bool SparkFun_AS3935_LinuxBus::openI2C(const char *device, uint8_t address)
+{
+    if (!_open(device))
+        return false;
+
+    _spi = false;
+    _address = address;
+    _speed = 0;
+
+    if (_mode == BUS_FILE)
+        return true;
+
+    unsigned long funcs = 0;
+    if (ioctl(_fd, I2C_FUNCS, &funcs) < 0)
+    {
+        close();
+        return false;
+    }
+
+    if (funcs & I2C_FUNC_I2C)
+        _mode = BUS_I2C;
+    else if ((funcs & I2C_FUNC_SMBUS_BYTE_DATA) == I2C_FUNC_SMBUS_BYTE_DATA &&
+             ioctl(_fd, I2C_SLAVE, address) >= 0)
+        _mode = BUS_SMBUS;
+    else
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// Opens a SPI device in SPI mode 1, most significant bit first.
+bool SparkFun_AS3935_LinuxBus::openSPI(const char *device, uint32_t speed)
+{
+    if (!_open(device))
+        return false;
+
+    _spi = true;
+    _speed = speed;
+
+    if (_mode == BUS_FILE)
+        return true;
+
+    uint8_t mode = SPI_MODE_1;
+    uint8_t bits = 8;
+    if (ioctl(_fd, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0)
+    {
+        close();
+        return false;
+    }
+
+    _mode = BUS_SPI;
+    return true;
+}
+
+void SparkFun_AS3935_LinuxBus::close()
+{
+    if (_fd >= 0)
+        ::close(_fd);
+
+    _fd = -1;
+    _mode = BUS_CLOSED;
+}
+
+bool SparkFun_AS3935_LinuxBus::readRegister(uint8_t reg, uint8_t &value)
+{
+    return readRegisters(reg, &value, 1);
+}
+
+// Reads count registers starting at reg. Each register is read with its own
+// I2C messages or SPI transfers, so this does not depend on the chip
+// incrementing the register address, but they all go to the kernel at once.
+bool SparkFun_AS3935_LinuxBus::readRegisters(uint8_t reg, uint8_t *values, uint8_t count)
+{
+    if (count == 0 || count > MAX_BURST)
+        return false;
+
+    if (_mode == BUS_FILE)
+        return pread(_fd, values, count, reg) == count;
+
+    if (_mode == BUS_I2C)
+    {
+        uint8_t regs[MAX_BURST];
+        struct i2c_msg msgs[2 * MAX_BURST];
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            regs[i] = reg + i;
+            msgs[2 * i].addr = _address;
+            msgs[2 * i].flags = 0;
+            msgs[2 * i].len = 1;
+            msgs[2 * i].buf = &regs[i];
+            msgs[2 * i + 1].addr = _address;
+            msgs[2 * i + 1].flags = I2C_M_RD;
+            msgs[2 * i + 1].len = 1;
+            msgs[2 * i + 1].buf = &values[i];
+        }
+
+        struct i2c_rdwr_ioctl_data data;
+        data.msgs = msgs;
+        data.nmsgs = 2 * count;
+        return ioctl(_fd, I2C_RDWR, &data) >= 0;
+    }
+
+    if (_mode == BUS_SMBUS)
+    {
+        // SMBus has no way to put several reads together.
+        for (uint8_t i = 0; i < count; i++)
+        {
+            union i2c_smbus_data data;
+            struct i2c_smbus_ioctl_data args;
+            args.read_write = I2C_SMBUS_READ;
+            args.command = reg + i;
+            args.size = I2C_SMBUS_BYTE_DATA;
+            args.data = &data;
+            if (ioctl(_fd, I2C_SMBUS, &args) < 0)
+                return false;
+            values[i] = data.byte;
+        }
+        return true;
+    }
+
+    if (_mode == BUS_SPI)
+    {
+        // According to datsheet, the chip select must be written HIGH, LOW,
+        // HIGH to correctly end the READ command. The empty transfer after each
+        // read does the LOW, HIGH.
+        uint8_t tx[MAX_BURST][2];
+        uint8_t rx[MAX_BURST][2];
+        struct spi_ioc_transfer xfers[2 * MAX_BURST];
+        memset(xfers, 0, sizeof(xfers[0]) * 2 * count);
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            tx[i][0] = (reg + i) | LINUX_SPI_READ;
+            tx[i][1] = 0;
+            xfers[2 * i].tx_buf = (unsigned long)tx[i];
+            xfers[2 * i].rx_buf = (unsigned long)rx[i];
+            xfers[2 * i].len = 2;
+            xfers[2 * i].speed_hz = _speed;
+            xfers[2 * i].bits_per_word = 8;
+            xfers[2 * i].cs_change = 1;
+            xfers[2 * i + 1].speed_hz = _speed;
+            xfers[2 * i + 1].bits_per_word = 8;
+            // On the last transfer cs_change would leave the chip selected.
+            xfers[2 * i + 1].cs_change = (i + 1 < count);
+        }
+
+        if (ioctl(_fd, SPI_IOC_MESSAGE(2 * count), xfers) < 0)
+            return false;
+
+        for (uint8_t i = 0; i < count; i++)
+            values[i] = rx[i][1];
+        return true;
+    }
+
+    return false;
+}
+
+bool SparkFun_AS3935_LinuxBus::writeRegister(uint8_t reg, uint8_t value)
+{
+    uint8_t buf[2] = {reg, value};
+
+    if (_mode == BUS_FILE)
+        return pwrite(_fd, &value, 1, reg) == 1;
+
+    if (_mode == BUS_I2C)
+    {
+        struct i2c_msg msg;
+        msg.addr = _address;
+        msg.flags = 0;
+        msg.len = 2;
+        msg.buf = buf;
+
+        struct i2c_rdwr_ioctl_data data;
+        data.msgs = &msg;
+        data.nmsgs = 1;
+        return ioctl(_fd, I2C_RDWR, &data) >= 0;
+    }
+
+    if (_mode == BUS_SMBUS)
+    {
+        union i2c_smbus_data data;
+        data.byte = value;
+
+        struct i2c_smbus_ioctl_data args;
+        args.read_write = I2C_SMBUS_WRITE;
+        args.command = reg;
+        args.size = I2C_SMBUS_BYTE_DATA;
+        args.data = &data;
+        return ioctl(_fd, I2C_SMBUS, &args) >= 0;
+    }
+
+    if (_mode == BUS_SPI)
+    {
+        struct spi_ioc_transfer xfer;
+        memset(&xfer, 0, sizeof(xfer));
+        xfer.tx_buf = (unsigned long)buf;
+        xfer.len = 2;
+        xfer.speed_hz = _speed;
+        xfer.bits_per_word = 8;
+        return ioctl(_fd, SPI_IOC_MESSAGE(1), &xfer) >= 0;
+    }
+
+    return false;
+}
+
+// Changes the SPI clock. It is given with every transfer, so nothing needs to
+// be sent to the driver here.
+bool SparkFun_AS3935_LinuxBus::setSpeed(uint32_t speed)
+{
+    if (!_spi)
+        return false;
+
+    _speed = speed;
+    return true;
+}
+
+uint32_t SparkFun_AS3935_LinuxBus::readSpeed()
+{
+    return _speed;
+}
+
+bool SparkFun_AS3935_LinuxBus::isSPI()
+{
+    return _spi;
+}
+
+// Opens the device and switches to file mode if it's a regular file.
+bool SparkFun_AS3935_LinuxBus::_open(const char *device)
+{
+    close();
+
+    _fd = open(device, O_RDWR);
+    if (_fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(_fd, &info) < 0)
+    {
+        close();
+        return false;
+    }
+
+    _mode = S_ISREG(info.st_mode) ? BUS_FILE : BUS_CLOSED;
+    return true;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef _SPARKFUN_AS3935_LINUX_H_
+#define _SPARKFUN_AS3935_LINUX_H_
+
+// Everything here is only used when the library is built outside of Arduino,
+// on a Linux board that talks to the detector through /dev/i2c-N or
+// /dev/spidevB.C. See extras/linux for how to build it.
+#if !defined(ARDUINO) && defined(__linux__)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// Prints to a stdio stream, enough for dumpTrace().
+class SparkFun_AS3935_Print
+{
+  public:
+    SparkFun_AS3935_Print(FILE *stream = stdout) : _stream(stream)
+    {
+    }
+    void print(const char *text)
+    {
+        fputs(text, _stream);
+    }
+    void print(unsigned long value, int base = 10)
+    {
+        fprintf(_stream, (base == 16) ? "%lX" : "%lu", value);
+    }
+    void println(const char *text = "")
+    {
+        fprintf(_stream, "%s\n", text);
+    }
+    void println(unsigned long value, int base = 10)
+    {
+        print(value, base);
+        println();
+    }
+
+  private:
+    FILE *_stream;
+};
+
+// Most register reads in the library are for a single byte, which this reads
+// with a single system call. Reads of several registers, such as the three
+// energy registers, are put into a single system call as well.
+class SparkFun_AS3935_LinuxBus
+{
+  public:
+    SparkFun_AS3935_LinuxBus();
+    ~SparkFun_AS3935_LinuxBus();
+
+    // Opens an I-squared-C bus, e.g. "/dev/i2c-1", at the given address.
+    // Combined write-then-read messages are used (I2C_RDWR). Adapters that
+    // only do SMBus, such as the i2c-stub module, fall back to SMBus byte
+    // reads and writes. A regular file can be given instead of a device, in
+    // which case byte N of the file stands in for register N.
+    bool openI2C(const char *device, uint8_t address);
+
+    // Opens a SPI device, e.g. "/dev/spidev0.0", in SPI mode 1. A regular
+    // file can be given instead, as for openI2C().
+    bool openSPI(const char *device, uint32_t speed);
+
+    void close();
+
+    // Each of these is one system call. Returns false if it failed.
+    bool readRegister(uint8_t reg, uint8_t &value);
+    bool readRegisters(uint8_t reg, uint8_t *values, uint8_t count);
+    bool writeRegister(uint8_t reg, uint8_t value);
+
+    // Changes the SPI clock. The I-squared-C clock is set by the kernel and
+    // can't be changed from here, this then returns false.
+    bool setSpeed(uint32_t speed);
+    uint32_t readSpeed();
+
+    bool isSPI();
+
+  private:
+    // Not copyable, as both copies would close the same device.
+    SparkFun_AS3935_LinuxBus(const SparkFun_AS3935_LinuxBus &);
+    SparkFun_AS3935_LinuxBus &operator=(const SparkFun_AS3935_LinuxBus &);
+
+    enum
+    {
+        BUS_CLOSED,
+        BUS_I2C,
+        BUS_SMBUS,
+        BUS_SPI,
+        BUS_FILE
+    };
+
+    int _fd;
+    uint8_t _mode;
+    bool _spi; // Opened through openSPI(), also for files.
+    uint8_t _address;
+    uint32_t _speed;
+
+    // Opens the device and switches to file mode if it's a regular file.
+    bool _open(const char *device);
+};
+
+#endif
+#endif
@@ -0,0 +1,103 @@
+#ifndef _SPARKFUN_AS3935_TRACE_H_
+#define _SPARKFUN_AS3935_TRACE_H_
+
+#include <stdint.h>
+
+// Uncomment the following line, or pass -DSFE_AS3935_TRACE in the build flags,
+// to record every register read, register write and delay into a buffer given
+// to setTraceBuffer(). When it is not defined none of the tracing code is
+// compiled in. extras/trace_timeline.py turns the output of dumpTrace() into a
+// timeline.
+// #define SFE_AS3935_TRACE
+
+// What happened on the bus.
+enum SF_AS3935_TRACE_KINDS
+{
+    AS3935_TRACE_READ = 0x00,
+    AS3935_TRACE_WRITE = 0x01,
+    AS3935_TRACE_DELAY = 0x02,  // The register is zero and the value is the delay in ms.
+    AS3935_TRACE_ADDRESS = 0x03 // Only the I-squared-C address was sent. The register
+                                // is zero and the value is the bus status, zero if
+                                // the chip answered.
+};
+
+// The public function that caused the bus transaction. When one public function
+// calls another, the outer one is recorded. The values are part of the dump
+// format, so new functions are added to the end.
+enum SF_AS3935_TRACE_CALLERS
+{
+    AS3935_TRACE_NONE = 0x00,
+    AS3935_TRACE_BEGIN = 0x01,
+    AS3935_TRACE_BEGIN_SPI = 0x02,
+    AS3935_TRACE_POWER_DOWN = 0x03,
+    AS3935_TRACE_WAKE_UP = 0x04,
+    AS3935_TRACE_SET_INDOOR_OUTDOOR = 0x05,
+    AS3935_TRACE_READ_INDOOR_OUTDOOR = 0x06,
+    AS3935_TRACE_WATCHDOG_THRESHOLD = 0x07,
+    AS3935_TRACE_READ_WATCHDOG_THRESHOLD = 0x08,
+    AS3935_TRACE_SET_NOISE_LEVEL = 0x09,
+    AS3935_TRACE_READ_NOISE_LEVEL = 0x0A,
+    AS3935_TRACE_SPIKE_REJECTION = 0x0B,
+    AS3935_TRACE_READ_SPIKE_REJECTION = 0x0C,
+    AS3935_TRACE_LIGHTNING_THRESHOLD = 0x0D,
+    AS3935_TRACE_READ_LIGHTNING_THRESHOLD = 0x0E,
+    AS3935_TRACE_CLEAR_STATISTICS = 0x0F,
+    AS3935_TRACE_READ_INTERRUPT_REG = 0x10,
+    AS3935_TRACE_MASK_DISTURBER = 0x11,
+    AS3935_TRACE_READ_MASK_DISTURBER = 0x12,
+    AS3935_TRACE_CHANGE_DIV_RATIO = 0x13,
+    AS3935_TRACE_READ_DIV_RATIO = 0x14,
+    AS3935_TRACE_DISTANCE_TO_STORM = 0x15,
+    AS3935_TRACE_DISPLAY_OSCILLATOR = 0x16,
+    AS3935_TRACE_TUNE_CAP = 0x17,
+    AS3935_TRACE_READ_TUNE_CAP = 0x18,
+    AS3935_TRACE_LIGHTNING_ENERGY = 0x19,
+    AS3935_TRACE_CALIBRATE_OSC = 0x1A,
+    AS3935_TRACE_RESET_SETTINGS = 0x1B,
+    AS3935_TRACE_PROBE_BUS_SPEED = 0x1C,
+    AS3935_TRACE_MEASURE_BUS_THROUGHPUT = 0x1D
+};
+
+// One 8 byte record per bus transaction or delay.
+typedef struct
+{
+    uint32_t timestamp; // micros() when the transaction finished.
+    uint8_t kind;       // SF_AS3935_TRACE_KINDS
+    uint8_t reg;        // Register address, without the SPI read bit.
+    uint8_t value;      // Byte read or written.
+    uint8_t caller;     // SF_AS3935_TRACE_CALLERS
+} as3935TraceRecord;
+
+#ifdef SFE_AS3935_TRACE
+
+// Sets the caller for as long as the public function runs, unless an outer
+// public function already did.
+class as3935TraceScope
+{
+  public:
+    as3935TraceScope(uint8_t &current, uint8_t caller) : _current(current), _set(current == AS3935_TRACE_NONE)
+    {
+        if (_set)
+            _current = caller;
+    }
+    ~as3935TraceScope()
+    {
+        if (_set)
+            _current = AS3935_TRACE_NONE;
+    }
+
+  private:
+    uint8_t &_current;
+    bool _set;
+};
+
+#define AS3935_TRACE_CALL(caller) as3935TraceScope _traceScope(_traceCaller, caller)
+#define AS3935_TRACE_EVENT(kind, reg, value) _traceRecord(kind, reg, value)
+
+#else
+
+#define AS3935_TRACE_CALL(caller)
+#define AS3935_TRACE_EVENT(kind, reg, value)
+
+#endif
+#endif